@@ -9,6 +9,7 @@
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/socket.h>
 
 // Signal Handling
@@ -26,6 +27,7 @@
 #define UNKNOWN_OPTION_MESSAGE_LEN 24
 #define BASE_TEN 10
 #define LINE_LENGTH 1024
+#define FAST_OPEN_QUEUE_LENGTH 16
 
 // ----- Function Headers -----
 
@@ -45,8 +47,12 @@ static void start_listening(int server_fd, int backlog);
 static void socket_connect(int sockfd, struct sockaddr_storage *addr, in_port_t port);
 static int  socket_accept_connection(int server_fd, struct sockaddr_storage *client_addr, socklen_t *client_addr_len);
 static void socket_close(int sockfd);
+static void socket_set_nodelay(int sockfd);
+static void socket_enable_fast_open(int sockfd);
 static void write_to_socket(int sockfd, const char *message);
 static int  read_from_socket(int sockfd);
+static int  read_fully(int sockfd, void *buffer, size_t len);
+static int  write_fully(int sockfd, const void *buffer, size_t len);
 
 // Network Helper Functions
 void host_connection(int sockfd, struct sockaddr_storage *addr, in_port_t port);
@@ -118,6 +124,9 @@ int main(int argc, char *argv[])
                 exit(EXIT_FAILURE);
             }
         }
+
+        // Only one peer is served, so stop accepting and let further connection attempts be refused
+        socket_close(host_sockfd);
     }
 
     setup_signal_handler();
@@ -125,6 +134,7 @@ int main(int argc, char *argv[])
     // Sets the receiving end sockfd to either client_sockfd or host_sockfd
     // If -a is set, receiver is client, If -c is set, receiver is host
     receiver_sockfd = listen_arg ? client_sockfd : host_sockfd;
+    socket_set_nodelay(receiver_sockfd);
 
     write_thread_result = pthread_create(&write_message_thread, NULL, write_message, (void *)&receiver_sockfd);
     read_thread_result  = pthread_create(&read_message_thread, NULL, read_message, (void *)&receiver_sockfd);
@@ -164,8 +174,7 @@ int main(int argc, char *argv[])
     pthread_join(write_message_thread, NULL);
     pthread_join(read_message_thread, NULL);
 
-    socket_close(client_sockfd);
-    socket_close(host_sockfd);
+    socket_close(receiver_sockfd);
     return EXIT_SUCCESS;
 }
 
@@ -541,6 +550,38 @@ static void socket_close(int sockfd)
     }
 }
 
+/**
+ * Disables Nagle's algorithm on a connected socket so each message is sent as soon as it is written.
+ * @param sockfd the file descriptor of the connected socket
+ */
+static void socket_set_nodelay(int sockfd)
+{
+    int enable = 1;
+    if(setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(int)) == -1)
+    {
+        perror("Setsockopt failed");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * Enables TCP Fast Open on a listening socket so data carried in a client's SYN is accepted without a round trip.
+ * Failure is not fatal, as the kernel may have server side fast open disabled.
+ * @param sockfd the file descriptor of the socket that will listen
+ */
+static void socket_enable_fast_open(int sockfd)
+{
+#ifdef TCP_FASTOPEN
+    int queue_length = FAST_OPEN_QUEUE_LENGTH;
+    if(setsockopt(sockfd, IPPROTO_TCP, TCP_FASTOPEN, &queue_length, sizeof(int)) == -1)
+    {
+        perror("TCP fast open unavailable");
+    }
+#else
+    (void)sockfd;
+#endif
+}
+
 // Network Helper Functions
 
 /**
@@ -558,6 +599,7 @@ void host_connection(int sockfd, struct sockaddr_storage *addr, in_port_t port)
         exit(EXIT_FAILURE);
     }
 
+    socket_enable_fast_open(sockfd);
     socket_bind(sockfd, addr, port);
     start_listening(sockfd, SOMAXCONN);
 }
@@ -653,6 +695,7 @@ static void *read_message(void *arg)
 
 /**
  * Writes a command string to a socket.
+ * The size and the command are sent with a single write so they leave in the same segment.
  * @param sockfd   the file descriptor of the socket to write to
  * @param command  the command string to write to the socket
  */
@@ -660,51 +703,137 @@ static void write_to_socket(int sockfd, const char *message)
 {
     size_t   message_len;
     uint16_t size;
+    char     frame[sizeof(uint16_t) + LINE_LENGTH];
 
-    message_len = strlen(message);
+    message_len = strnlen(message, LINE_LENGTH);
     size        = (uint16_t)message_len;
 
-    write(sockfd, &size, sizeof(uint16_t));    // Write the size of the command
-    write(sockfd, message, message_len);       // Write the command string
+    memcpy(frame, &size, sizeof(uint16_t));                    // Write the size of the command
+    memcpy(frame + sizeof(uint16_t), message, message_len);    // Write the command string
+
+    if(write_fully(sockfd, frame, sizeof(uint16_t) + message_len) == -1)    // Check if connection is closed
+    {
+        sigtstp_flag = 1;
+    }
 }
 
 /**
- * Reads input from the network socket
- * @param client_sockfd   the file descriptor for the connected client socket
- * @param client_addr     a pointer to a struct sockaddr_storage containing client address information
+ * Reads a message from the network socket and writes it to stdout.
+ * The payload is relayed in LINE_LENGTH chunks, so a frame of any size fits the fixed buffer.
+ * @param sockfd the file descriptor of the connected socket
+ * @return       EXIT_SUCCESS on success, EXIT_FAILURE if the connection is closed or stdout fails
  */
 static int read_from_socket(int sockfd)
 {
-    ssize_t  bytes_read;
     uint16_t size;
+    size_t   remaining;
     char     buffer[LINE_LENGTH];
 
-    bytes_read = read(sockfd, &size, sizeof(uint16_t));
-
-    if(bytes_read < 1)    // Check if connection is closed
+    if(read_fully(sockfd, &size, sizeof(uint16_t)) == -1)    // Check if connection is closed
     {
         sigtstp_flag = 1;
         return EXIT_FAILURE;
     }
 
-    bytes_read = read(sockfd, buffer, size);
+    remaining = size;
 
-    if(bytes_read < 1)    // Check if connection is closed
+    while(remaining > 0)
     {
-        sigtstp_flag = 1;
-        return EXIT_FAILURE;
-    }
+        size_t chunk_len;
 
-    buffer[(int)bytes_read] = '\0';
+        chunk_len = remaining < sizeof(buffer) ? remaining : sizeof(buffer);
 
-    if(write(STDOUT_FILENO, buffer, strlen(buffer)) == -1)
-    {
-        //        perror("write");
-        //        close(sockfd);
-        return EXIT_FAILURE;
+        if(read_fully(sockfd, buffer, chunk_len) == -1)    // Check if connection is closed
+        {
+            sigtstp_flag = 1;
+            return EXIT_FAILURE;
+        }
+
+        if(write(STDOUT_FILENO, buffer, chunk_len) == -1)
+        {
+            return EXIT_FAILURE;
+        }
+
+        remaining -= chunk_len;
     }
 
     fflush(stdout);
 
     return EXIT_SUCCESS;
 }
+
+/**
+ * Reads exactly len bytes from a socket, retrying on short reads and interrupts.
+ * @param sockfd the file descriptor of the socket to read from
+ * @param buffer the buffer to store the bytes in
+ * @param len    the number of bytes to read
+ * @return       0 on success, or -1 if the connection is closed or an error occurs
+ */
+static int read_fully(int sockfd, void *buffer, size_t len)
+{
+    char  *cursor;
+    size_t remaining;
+
+    cursor    = (char *)buffer;
+    remaining = len;
+
+    while(remaining > 0)
+    {
+        ssize_t bytes_read;
+
+        bytes_read = read(sockfd, cursor, remaining);
+
+        if(bytes_read == -1 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if(bytes_read < 1)
+        {
+            return -1;
+        }
+
+        cursor += bytes_read;
+        remaining -= (size_t)bytes_read;
+    }
+
+    return 0;
+}
+
+/**
+ * Writes exactly len bytes to a socket, retrying on short writes and interrupts.
+ * @param sockfd the file descriptor of the socket to write to
+ * @param buffer the bytes to write
+ * @param len    the number of bytes to write
+ * @return       0 on success, or -1 if an error occurs
+ */
+static int write_fully(int sockfd, const void *buffer, size_t len)
+{
+    const char *cursor;
+    size_t      remaining;
+
+    cursor    = (const char *)buffer;
+    remaining = len;
+
+    while(remaining > 0)
+    {
+        ssize_t bytes_written;
+
+        bytes_written = write(sockfd, cursor, remaining);
+
+        if(bytes_written == -1 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if(bytes_written < 1)
+        {
+            return -1;
+        }
+
+        cursor += bytes_written;
+        remaining -= (size_t)bytes_written;
+    }
+
+    return 0;
+}